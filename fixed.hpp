@@ -52,6 +52,26 @@
  * 
  * #define  __fixed_use_fast_float_convertion
  * 
+ * For int8/int16 quantized inference there are batch routines fixed::quantize(), fixed::dequantize() (per-tensor and per-channel)
+ *  and fixed::gemv() (int8 x int8 matrix-vector product accumulated into 'fixed'); the scale is given as 'fixed' multiplier and shift,
+ *  so the whole requantization path uses integer arithmetic only, and the loops are branch-free to be vectorized by the compiler
+ *  (on x86 with -msse4.2 / -mavx2 and higher)
+ * 
+ * On 8/32-bit MCUs the multiplication and division of two 64-bit integers are emulated by slow library calls,
+ *  to perform all operations of class 'fixed' using only 32x32->64 multiplications and 32-bit divisions (over hi/lo 32-bit words), uncomment the line:
+ * 
+ * #define  __fixed_use_32bit_arithmetics
+ * 
+ * (the results are bit for bit the same as with the plain 64-bit arithmetics, so this mode can be checked on a PC as well)
+ * 
+ * To guarantee that no floating-point instruction is executed inside any operation of class 'fixed' (bit-exact results on any machine,
+ *  e.g. for lockstep simulation), uncomment the line:
+ * 
+ * #define  __fixed_strict_integer
+ * 
+ * in this mode arithmetics and comparison with float/double operands are rejected at compile time, conversions from/to float/double
+ *  must be written explicitly (a * fixed(0.5),  float(a)), and __fixed_use_float_for_div is not allowed
+ * 
  * 
  * (russian language annotation):
  * 
@@ -102,6 +122,26 @@
  * 
  * #define  __fixed_use_fast_float_convertion
  * 
+ * Для квантованных (int8/int16) нейросетевых вычислений есть пакетные функции fixed::quantize(), fixed::dequantize() (на весь тензор или по каналам)
+ *  и fixed::gemv() (умножение int8-матрицы на int8-вектор с накоплением в 'fixed'); масштаб задаётся множителем типа 'fixed' и сдвигом,
+ *  так что весь путь переквантования выполняется только целочисленной арифметикой, а циклы без ветвлений векторизуются компилятором
+ *  (на x86 с -msse4.2 / -mavx2 и выше)
+ * 
+ * На 8/32-битных микроконтроллерах умножение и деление двух 64-битных целых эмулируются медленными библиотечными функциями,
+ *  чтобы все операции класса 'fixed' выполнялись только умножениями 32x32->64 и 32-битными делениями (над старшим/младшим 32-битными словами), раскоментируйте строчку:
+ * 
+ * #define  __fixed_use_32bit_arithmetics
+ * 
+ * (результаты побитово совпадают с обычной 64-битной арифметикой, поэтому этот режим можно проверить и на PC)
+ * 
+ * Чтобы гарантировать, что ни одна операция класса 'fixed' не выполняет инструкций плавающей арифметики (побитово одинаковый результат на любой машине,
+ *  например для синхронной (lockstep) симуляции), раскоментируйте строчку:
+ * 
+ * #define  __fixed_strict_integer
+ * 
+ * в этом режиме арифметика и сравнение с операндами типа float/double запрещены на этапе компиляции, преобразования из/в float/double
+ *  нужно писать явно (a * fixed(0.5),  float(a)), а __fixed_use_float_for_div использовать нельзя
+ * 
  * 
  * by Vasyl Ruskykh  (mailto: domanet.adm@gmail.com,  https://www.facebook.com/vasyl.diver)
  * 
@@ -112,6 +152,18 @@
 
 //#define  __fixed_use_float_for_div
 //#define  __fixed_use_fast_float_convertion
+//#define  __fixed_use_32bit_arithmetics
+//#define  __fixed_strict_integer
+
+
+#ifdef __fixed_strict_integer
+  #ifdef __fixed_use_float_for_div
+    #error "__fixed_use_float_for_div performs division by floating-point arithmetics and can not be used together with __fixed_strict_integer"
+  #endif
+  #define  __fixed_float_boundary  explicit      // conversions from/to float/double are allowed only explicitly:  fixed(0.5),  float(a)
+#else
+  #define  __fixed_float_boundary
+#endif
 
 
 class fixed
@@ -130,8 +182,8 @@ public:
   inline fixed(uint16_t x)  { ff = int64_t(x) << 24; }
   inline fixed(uint32_t x)  { ff = int64_t(x) << 24; }
   inline fixed(uint64_t x)  { ff = int64_t(x) << 24; }
-  inline fixed(float x);    //     { ff = int64_t( x *  float(uint32_t(1)<<24) ); }    // единицу явно указываем 32-разрядной, чтобы при сдвиге влево на 24 разряда не "вылететь" за пределы разрядности
-  inline fixed(double x);
+  __fixed_float_boundary inline fixed(float x);    //     { ff = int64_t( x *  float(uint32_t(1)<<24) ); }    // единицу явно указываем 32-разрядной, чтобы при сдвиге влево на 24 разряда не "вылететь" за пределы разрядности
+  __fixed_float_boundary inline fixed(double x);
 
   // оператор присваивания 
   //
@@ -143,15 +195,15 @@ public:
   
   // преобразование к стандартным типам данных
   //
-  inline operator double() const;
-  inline operator  float() const;
+  __fixed_float_boundary inline operator double() const;
+  __fixed_float_boundary inline operator  float() const;
   inline operator    int() const   { register int64_t a = ff;  if(a < 0) { return  -int((-a)>>24);} else { return   int(a>>24);} }
   inline operator  short() const   { register int64_t a = ff;  if(a < 0) { return  -int((-a)>>24);} else { return short(a>>24);} }
   inline operator   long() const   { register int64_t a = ff;  if(a < 0) { return -long((-a)>>24);} else { return  long(a>>24);} }
   inline operator unsigned   int() const   { register int64_t a = ff;  if(a < 0) { return  -int((-a)>>24);} else { return (unsigned   int)(a>>24);} }
   inline operator unsigned short() const   { register int64_t a = ff;  if(a < 0) { return  -int((-a)>>24);} else { return (unsigned short)(a>>24);} }
   inline operator unsigned  long() const   { register int64_t a = ff;  if(a < 0) { return  -int((-a)>>24);} else { return (unsigned  long)(a>>24);} }
-  inline operator int64_t() const  { register int64_t a = ff;  if(a < 0) { return -int64_t((-a)>>24);} else { return int64_t(a>>24);} }
+  inline operator long long() const   { register int64_t a = ff;  if(a < 0) { return -(long long)((-a)>>24);} else { return (long long)(a>>24);} }
 
   // базовые арифметические операции внутри одного типа
   //
@@ -170,6 +222,30 @@ public:
 
   // арифметические операции с типом double/float
   //
+#ifdef __fixed_strict_integer
+  //
+  // в строго целочисленном режиме операции с float/double запрещены (они неявно выполняются в плавающей арифметике),  пишите явно:  a * fixed(0.5)
+  //
+  inline fixed operator + (const double &x) const = delete;
+  inline fixed operator + (const float  &x) const = delete;
+  inline fixed operator - (const double &x) const = delete;
+  inline fixed operator - (const float  &x) const = delete;
+  inline fixed operator * (const double &x) const = delete;
+  inline fixed operator * (const float  &x) const = delete;
+  inline fixed operator / (const double &x) const = delete;
+  inline fixed operator / (const float  &x) const = delete;
+
+  inline fixed& operator +=(const double &x) = delete;
+  inline fixed& operator +=(const float  &x) = delete;
+  inline fixed& operator -=(const double &x) = delete;
+  inline fixed& operator -=(const float  &x) = delete;
+  inline fixed& operator *=(const double &x) = delete;
+  inline fixed& operator *=(const float  &x) = delete;
+  inline fixed& operator /=(const double &x) = delete;
+  inline fixed& operator /=(const float  &x) = delete;
+  //
+#else
+  //
   inline fixed operator + (const double &x) const  { return operator + (fixed(x)); }
   inline fixed operator + (const float  &x) const  { return operator + (fixed(x)); }
   inline fixed operator - (const double &x) const  { return operator - (fixed(x)); }
@@ -211,6 +287,8 @@ public:
   inline fixed& operator /=(const double &x) { ff = float(ff) / float(x);  return (*this); }
   //
 #endif
+  //
+#endif  // __fixed_strict_integer
   
   
   // арифметическае операции к самому объекту с другим типом данных, которые можно реализовать быстрее чем через приведение типов (см.умножение)
@@ -229,12 +307,12 @@ public:
   inline fixed& operator -=(const uint32_t &x)  { ff -= int64_t(x) << 24;  return (*this); }
   inline fixed& operator -=(const uint64_t &x)  { ff -= int64_t(x) << 24;  return (*this); }
   
-  inline fixed& operator *=(const  int16_t &x)  { ff *= x;  return (*this); }
-  inline fixed& operator *=(const  int32_t &x)  { ff *= x;  return (*this); }
-  inline fixed& operator *=(const  int64_t &x)  { ff *= x;  return (*this); }
-  inline fixed& operator *=(const uint16_t &x)  { ff *= x;  return (*this); }
-  inline fixed& operator *=(const uint32_t &x)  { ff *= x;  return (*this); }
-  inline fixed& operator *=(const uint64_t &x)  { ff *= x;  return (*this); }
+  inline fixed& operator *=(const  int16_t &x)  { ff = mul64(ff, x);  return (*this); }
+  inline fixed& operator *=(const  int32_t &x)  { ff = mul64(ff, x);  return (*this); }
+  inline fixed& operator *=(const  int64_t &x)  { ff = mul64(ff, x);  return (*this); }
+  inline fixed& operator *=(const uint16_t &x)  { ff = mul64(ff, x);  return (*this); }
+  inline fixed& operator *=(const uint32_t &x)  { ff = mul64(ff, x);  return (*this); }
+  inline fixed& operator *=(const uint64_t &x)  { ff = mul64(ff, x);  return (*this); }
   
 #ifdef __fixed_use_float_for_div      
   //
@@ -249,12 +327,12 @@ public:
   //
 #else
   //
-  inline fixed& operator /=(const  int16_t &x)  { if(x !=  int16_t(0)) { ff /= x; return (*this); }  else { return operator /=(fixed(x)); } }
-  inline fixed& operator /=(const  int32_t &x)  { if(x !=  int32_t(0)) { ff /= x; return (*this); }  else { return operator /=(fixed(x)); } }   // if division by zero - resolve this problem by 'fixed' class standart method
-  inline fixed& operator /=(const  int64_t &x)  { if(x !=  int64_t(0)) { ff /= x; return (*this); }  else { return operator /=(fixed(x)); } }
-  inline fixed& operator /=(const uint16_t &x)  { if(x != uint16_t(0)) { ff /= x; return (*this); }  else { return operator /=(fixed(x)); } }
-  inline fixed& operator /=(const uint32_t &x)  { if(x != uint32_t(0)) { ff /= x; return (*this); }  else { return operator /=(fixed(x)); } }
-  inline fixed& operator /=(const uint64_t &x)  { if(x != uint64_t(0)) { ff /= x; return (*this); }  else { return operator /=(fixed(x)); } }
+  inline fixed& operator /=(const  int16_t &x)  { if(x !=  int16_t(0)) { ff = div64(ff, x); return (*this); }  else { return operator /=(fixed(x)); } }
+  inline fixed& operator /=(const  int32_t &x)  { if(x !=  int32_t(0)) { ff = div64(ff, x); return (*this); }  else { return operator /=(fixed(x)); } }   // if division by zero - resolve this problem by 'fixed' class standart method
+  inline fixed& operator /=(const  int64_t &x)  { if(x !=  int64_t(0)) { ff = div64(ff, x); return (*this); }  else { return operator /=(fixed(x)); } }
+  inline fixed& operator /=(const uint16_t &x)  { if(x != uint16_t(0)) { ff = div64(ff, x); return (*this); }  else { return operator /=(fixed(x)); } }
+  inline fixed& operator /=(const uint32_t &x)  { if(x != uint32_t(0)) { ff = div64(ff, x); return (*this); }  else { return operator /=(fixed(x)); } }
+  inline fixed& operator /=(const uint64_t &x)  { if(x != uint64_t(0)) { ff = int64_t(udiv64(uint64_t(ff), x)); return (*this); }  else { return operator /=(fixed(x)); } }
   //inline fixed& operator /=(const uint64_t &x)  { ff /= x;  return (*this); }
   //
 #endif
@@ -276,12 +354,12 @@ public:
   inline fixed operator - (const uint32_t &x) const  { fixed z;  z.ff = ff - int64_t(x) << 24;  return z; }
   inline fixed operator - (const uint64_t &x) const  { fixed z;  z.ff = ff - int64_t(x) << 24;  return z; }
 
-  inline fixed operator * (const  int16_t &x) const  { fixed z;  z.ff = ff * x;  return z; }
-  inline fixed operator * (const  int32_t &x) const  { fixed z;  z.ff = ff * x;  return z; }
-  inline fixed operator * (const  int64_t &x) const  { fixed z;  z.ff = ff * x;  return z; }
-  inline fixed operator * (const uint16_t &x) const  { fixed z;  z.ff = ff * x;  return z; }
-  inline fixed operator * (const uint32_t &x) const  { fixed z;  z.ff = ff * x;  return z; }
-  inline fixed operator * (const uint64_t &x) const  { fixed z;  z.ff = ff * x;  return z; }
+  inline fixed operator * (const  int16_t &x) const  { fixed z;  z.ff = mul64(ff, x);  return z; }
+  inline fixed operator * (const  int32_t &x) const  { fixed z;  z.ff = mul64(ff, x);  return z; }
+  inline fixed operator * (const  int64_t &x) const  { fixed z;  z.ff = mul64(ff, x);  return z; }
+  inline fixed operator * (const uint16_t &x) const  { fixed z;  z.ff = mul64(ff, x);  return z; }
+  inline fixed operator * (const uint32_t &x) const  { fixed z;  z.ff = mul64(ff, x);  return z; }
+  inline fixed operator * (const uint64_t &x) const  { fixed z;  z.ff = mul64(ff, x);  return z; }
 
 #ifdef __fixed_use_float_for_div      
   //
@@ -296,12 +374,12 @@ public:
   //
 #else
   //
-  inline fixed operator / (const  int16_t &x) const  { fixed z;  if(x !=  int16_t(0)) { z.ff = ff / x; return (*this); }  else { return operator /(fixed(x));  return z; } }   // if division by zero - resolve this problem by 'fixed' class standart method
-  inline fixed operator / (const  int32_t &x) const  { fixed z;  if(x !=  int32_t(0)) { z.ff = ff / x; return (*this); }  else { return operator /(fixed(x));  return z; } }
-  inline fixed operator / (const  int64_t &x) const  { fixed z;  if(x !=  int64_t(0)) { z.ff = ff / x; return (*this); }  else { return operator /(fixed(x));  return z; } }
-  inline fixed operator / (const uint16_t &x) const  { fixed z;  if(x != uint16_t(0)) { z.ff = ff / x; return (*this); }  else { return operator /(fixed(x));  return z; } }
-  inline fixed operator / (const uint32_t &x) const  { fixed z;  if(x != uint32_t(0)) { z.ff = ff / x; return (*this); }  else { return operator /(fixed(x));  return z; } }
-  inline fixed operator / (const uint64_t &x) const  { fixed z;  if(x != uint64_t(0)) { z.ff = ff / x; return (*this); }  else { return operator /(fixed(x));  return z; } }
+  inline fixed operator / (const  int16_t &x) const  { fixed z;  if(x !=  int16_t(0)) { z.ff = div64(ff, x); return z; }  else { return operator /(fixed(x));  return z; } }   // if division by zero - resolve this problem by 'fixed' class standart method
+  inline fixed operator / (const  int32_t &x) const  { fixed z;  if(x !=  int32_t(0)) { z.ff = div64(ff, x); return z; }  else { return operator /(fixed(x));  return z; } }
+  inline fixed operator / (const  int64_t &x) const  { fixed z;  if(x !=  int64_t(0)) { z.ff = div64(ff, x); return z; }  else { return operator /(fixed(x));  return z; } }
+  inline fixed operator / (const uint16_t &x) const  { fixed z;  if(x != uint16_t(0)) { z.ff = div64(ff, x); return z; }  else { return operator /(fixed(x));  return z; } }
+  inline fixed operator / (const uint32_t &x) const  { fixed z;  if(x != uint32_t(0)) { z.ff = div64(ff, x); return z; }  else { return operator /(fixed(x));  return z; } }
+  inline fixed operator / (const uint64_t &x) const  { fixed z;  if(x != uint64_t(0)) { z.ff = int64_t(udiv64(uint64_t(ff), x)); return z; }  else { return operator /(fixed(x));  return z; } }
   //
 #endif
 
@@ -317,6 +395,24 @@ public:
 
   // операции сравнения с типом double/float
   //
+#ifdef __fixed_strict_integer
+  //
+  inline bool operator ==(const float  &x) const = delete;
+  inline bool operator !=(const float  &x) const = delete;
+  inline bool operator < (const float  &x) const = delete;
+  inline bool operator <=(const float  &x) const = delete;
+  inline bool operator > (const float  &x) const = delete;
+  inline bool operator >=(const float  &x) const = delete;
+
+  inline bool operator ==(const double &x) const = delete;
+  inline bool operator !=(const double &x) const = delete;
+  inline bool operator < (const double &x) const = delete;
+  inline bool operator <=(const double &x) const = delete;
+  inline bool operator > (const double &x) const = delete;
+  inline bool operator >=(const double &x) const = delete;
+  //
+#else
+  //
   inline bool operator ==(const float &x) const  { return operator ==(fixed(x)); };
   inline bool operator !=(const float &x) const  { return operator !=(fixed(x)); };
   inline bool operator < (const float &x) const  { return operator < (fixed(x)); };
@@ -330,6 +426,8 @@ public:
   inline bool operator <=(const double &x) const  { return operator <=(fixed(x)); };
   inline bool operator > (const double &x) const  { return operator > (fixed(x)); };
   inline bool operator >=(const double &x) const  { return operator >=(fixed(x)); };
+  //
+#endif
 
   // операции сравнения с целыми числами
   // 
@@ -375,6 +473,60 @@ public:
   inline bool operator >=(const uint32_t &x) const  { return int64_t(*this)>=int64_t(x); };
   inline bool operator >=(const uint64_t &x) const  { return int64_t(*this)>=int64_t(x); };
 
+
+  // пакетное квантование/деквантование массивов fixed <-> int8/int16 (для квантованных нейросетей), только целочисленная арифметика
+  //
+  // scale is given as 'fixed' multiplier and power-of-two shift:  factor = multiplier * 2^shift  (shift may be negative)
+  //   quantize:    q = clamp( round(x * factor) + zero_point )     - here factor is the inverse scale (1/scale), so no division is needed
+  //                the result is exact (and saturated to the range of the output type) for any x if  |multiplier| < 2^15,  shift >= -20
+  //                and zero_point is within the range of the output type
+  //   dequantize:  x = (q - zero_point) * factor                   - here factor is the scale itself
+  // rounding is to nearest, ties are rounded up (toward +infinity)
+  //
+  // per-channel variants: data is laid out as [channels][inner], channel c uses multipliers[c] and shifts[c]
+  //
+  static inline void quantize  (const fixed   *src,  int8_t *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point);
+  static inline void quantize  (const fixed   *src, int16_t *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point);
+  static inline void dequantize(const  int8_t *src, fixed   *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point);
+  static inline void dequantize(const int16_t *src, fixed   *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point);
+
+  static inline void quantize  (const fixed   *src,  int8_t *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point);
+  static inline void quantize  (const fixed   *src, int16_t *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point);
+  static inline void dequantize(const  int8_t *src, fixed   *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point);
+  static inline void dequantize(const int16_t *src, fixed   *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point);
+
+  // int8 x int8 матрично-векторное умножение с накоплением в fixed:   y[r] += factor[r] * sum_c (w[r][c] - w_zero_point) * (x[c] - x_zero_point)
+  //  (w is row-major [rows][cols], accumulation is done in int32, then the sum is requantized to 'fixed' by per-row multiplier/shift)
+  //
+  static inline void gemv(const int8_t *w, const int8_t *x, fixed *y, uint32_t rows, uint32_t cols, int32_t w_zero_point, int32_t x_zero_point, const fixed *multipliers, const int8_t *shifts);
+  static inline void gemv(const int8_t *w, const int8_t *x, fixed *y, uint32_t rows, uint32_t cols, int32_t w_zero_point, int32_t x_zero_point, const fixed &multiplier,  int8_t shift);
+
+  // 64-битные умножение (младшие 64 бита произведения) и деление, через которые выполняются все операции класса
+  //  (public, so that the __fixed_use_32bit_arithmetics backend can be compared with the plain 64-bit one, see tests/backend_test.cpp)
+  //
+  static inline int64_t  mul64 (int64_t  a, int64_t  b);
+  static inline int64_t  div64 (int64_t  a, int64_t  b);     // b != 0,  rounding toward zero (as operator / of int64_t)
+  static inline uint64_t udiv64(uint64_t a, uint64_t b);     // b != 0
+
+  //
+private:
+
+  static inline int64_t round_shift(int64_t a, int32_t s);                       // a * 2^(-s)  rounded to nearest (ties up),  0 if |s| >= 64
+  static inline int64_t scale_raw(int64_t q, int64_t m, int8_t shift)  { return round_shift(mul64(q, m), -int32_t(shift)); }
+
+  template <typename T>
+  static inline void quantize_span(const fixed *src, T *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point, int32_t lo, int32_t hi);
+  template <typename T>
+  static inline void dequantize_span(const T *src, fixed *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point);
+
+  // общее тело gemv:  row r uses multipliers[r*step], shifts[r*step]  (step 1 - per row,  step 0 - one factor for all rows)
+  static inline void gemv_span(const int8_t *w, const int8_t *x, fixed *y, uint32_t rows, uint32_t cols, int32_t w_zero_point, int32_t x_zero_point, const fixed *multipliers, const int8_t *shifts, uint32_t step);
+
+#ifdef __fixed_use_32bit_arithmetics
+  static inline int32_t  nlz32(uint32_t x);                                // number of leading zero bits,  x != 0
+  static inline uint32_t divlu(uint32_t u1, uint32_t u0, uint32_t v);     // (u1:u0) / v  where u1 < v,  using 32-bit divisions only
+#endif
+
   //
 };
 
@@ -589,7 +741,7 @@ inline fixed fixed::operator * (const fixed &x) const
   //y.ff = (ff>>12) * (x.ff>>12); 
   //y.ff = ((ff>>8) * (x.ff>>8)) >> 8;      // умножаем сдвинутые именно на 8 (а не 24/2=12) разрядов оба числа, чтобы обеспечить бОльшую точность, после чего еше сдвигаем на 8 разрядов, чтобы в итоге получить сдвиг вправо на 24 разряда
 
-  a >>= 8;  b >>= 8;  a *= b;  a >>= 8;
+  a >>= 8;  b >>= 8;  a = mul64(a, b);  a >>= 8;
 
   if(sign!=false)  { a = -a; }          // correct sign
 
@@ -611,7 +763,7 @@ inline fixed& fixed::operator *= (const fixed &x)
   
   // ff = ((ff>>8) * (x.ff>>8)) >> 8; 
 
-  a >>= 8;  b >>= 8;  a *= b;  a >>= 8;
+  a >>= 8;  b >>= 8;  a = mul64(a, b);  a >>= 8;
 
   if(sign!=false)  { a = -a; }          // correct sign
 
@@ -644,7 +796,7 @@ inline fixed fixed::operator / (const fixed &x) const
   
   if(b != int64_t(0))
   {
-    a /= b;  a <<= 6;
+    a = div64(a, b);  a <<= 6;
   
     if(sign!=false)  { a = -a; }             // correct sign
   
@@ -652,7 +804,7 @@ inline fixed fixed::operator / (const fixed &x) const
   }
   else
   {
-    if( ff * x.ff >= 0 )
+    if( mul64(ff, x.ff) >= 0 )
     {
       z.ff = (const int64_t) (( !(uint64_t(0)) ) >> 2);        // just very big positive value
     }
@@ -692,7 +844,7 @@ inline fixed& fixed::operator /= (const fixed &x)
   
   if(b != int64_t(0))
   {
-    a /= b;  a <<= 6;
+    a = div64(a, b);  a <<= 6;
   
     if(sign!=false)  { a = -a; }           // correct sign
   
@@ -700,7 +852,7 @@ inline fixed& fixed::operator /= (const fixed &x)
   }
   else
   {
-    if( ff * x.ff >= 0 )
+    if( mul64(ff, x.ff) >= 0 )
     {
       ff = (const int64_t) (( !(uint64_t(0)) ) >> 2);        // just very big positive value
     }
@@ -715,3 +867,273 @@ inline fixed& fixed::operator /= (const fixed &x)
   return (*this);
 }
 
+
+
+#ifdef __fixed_use_32bit_arithmetics
+//
+// 64-битные числа обрабатываются как пары 32-битных слов (hi:lo), используются только умножения 32x32->64 и 32-битные деления
+//  (on 8/32-bit MCUs 64x64 multiply and 64/64 divide are emulated by slow library calls, while the 32-bit operations are native or much cheaper)
+// the results are bit for bit the same as of the plain 64-bit operations
+//
+
+inline int64_t fixed::mul64(int64_t a, int64_t b)
+{
+  register uint32_t a0 = uint32_t(uint64_t(a)),  a1 = uint32_t(uint64_t(a) >> 32);
+  register uint32_t b0 = uint32_t(uint64_t(b)),  b1 = uint32_t(uint64_t(b) >> 32);
+
+  register uint64_t lo = uint64_t(a0) * b0;                           // 32x32->64
+  register uint32_t hi = uint32_t(lo >> 32) + a1*b0 + a0*b1;          // only low 32 bits of the cross products are needed, a1*b1 is out of 64 bits at all
+
+  return int64_t( (uint64_t(hi) << 32) | uint32_t(lo) );
+}
+
+
+inline int32_t fixed::nlz32(uint32_t x)
+{
+  register int32_t n = 0;
+
+  if(x <= 0x0000FFFF)  { n += 16;  x <<= 16; }
+  if(x <= 0x00FFFFFF)  { n +=  8;  x <<=  8; }
+  if(x <= 0x0FFFFFFF)  { n +=  4;  x <<=  4; }
+  if(x <= 0x3FFFFFFF)  { n +=  2;  x <<=  2; }
+  if(x <= 0x7FFFFFFF)  { n +=  1; }
+
+  return n;
+}
+
+
+inline uint32_t fixed::divlu(uint32_t u1, uint32_t u0, uint32_t v)
+{
+  // деление "столбиком" 16-битными цифрами (Knuth, algorithm D;  H.Warren "Hacker's Delight", divlu)
+  //
+  const uint32_t b = 65536;
+
+  register int32_t s = nlz32(v);      // normalize divisor, so the quotient digit estimation is off by at most 2
+  v <<= s;
+
+  register uint32_t vn1 = v >> 16,  vn0 = v & 0xFFFF;
+
+  register uint32_t un32 = (s == 0) ? u1 : ((u1 << s) | (u0 >> (32 - s)));
+  register uint32_t un10 = u0 << s;
+  register uint32_t un1  = un10 >> 16,  un0 = un10 & 0xFFFF;
+
+  register uint32_t q1   = un32 / vn1;
+  register uint32_t rhat = un32 - q1*vn1;
+
+  while( q1 >= b  ||  q1*vn0 > b*rhat + un1 )  { q1--;  rhat += vn1;  if(rhat >= b) { break; } }
+
+  register uint32_t un21 = un32*b + un1 - q1*v;
+
+  register uint32_t q0 = un21 / vn1;
+  rhat = un21 - q0*vn1;
+
+  while( q0 >= b  ||  q0*vn0 > b*rhat + un0 )  { q0--;  rhat += vn1;  if(rhat >= b) { break; } }
+
+  return q1*b + q0;
+}
+
+
+inline uint64_t fixed::udiv64(uint64_t a, uint64_t b)
+{
+  register uint32_t a1 = uint32_t(a >> 32),  a0 = uint32_t(a);
+  register uint32_t b1 = uint32_t(b >> 32),  b0 = uint32_t(b);
+
+  if(b1 == 0)       // 32-bit divisor
+  {
+    if(a1 < b0)  { return divlu(a1, a0, b0); }
+
+    register uint32_t q1 = a1 / b0;        // high word of the quotient,  the remainder (a1 - q1*b0) < b0
+
+    return (uint64_t(q1) << 32) | divlu(a1 - q1*b0, a0, b0);
+  }
+
+  // divisor is at least 2^32, so the quotient fits in 32 bits:  estimate it by the normalized high word of the divisor and correct by one
+  //
+  register int32_t  n  = nlz32(b1);
+  register uint32_t bn = uint32_t((b << n) >> 32);
+  register uint64_t a2 = a >> 1;                      // so that the high word is less than bn
+
+  register uint64_t q = (uint64_t(divlu(uint32_t(a2 >> 32), uint32_t(a2), bn)) << n) >> 31;
+
+  if(q != 0)  { q--; }
+  if(a - uint64_t(mul64(int64_t(q), int64_t(b))) >= b)  { q++; }
+
+  return q;
+}
+
+
+inline int64_t fixed::div64(int64_t a, int64_t b)
+{
+  register bool sign = false;
+  register uint64_t ua = uint64_t(a),  ub = uint64_t(b);
+
+  if(a < 0)  { ua = uint64_t(0) - ua;  sign ^= 1; }
+  if(b < 0)  { ub = uint64_t(0) - ub;  sign ^= 1; }
+
+  register uint64_t q = udiv64(ua, ub);
+
+  return (sign!=false) ? int64_t(uint64_t(0) - q) : int64_t(q);
+}
+
+#else
+
+inline int64_t  fixed::mul64 (int64_t  a, int64_t  b)  { return a * b; }
+inline int64_t  fixed::div64 (int64_t  a, int64_t  b)  { return a / b; }
+inline uint64_t fixed::udiv64(uint64_t a, uint64_t b)  { return a / b; }
+
+#endif
+
+
+inline int64_t fixed::round_shift(int64_t a, int32_t s)
+{
+  // без ветвлений (только выбор по s, который внутри циклов не меняется), чтобы циклы с этой функцией векторизовались
+  //
+  register int32_t  sl = (s < 0) ? -s : 0;                                          // left shift  (done over unsigned value, so it is defined for negative values too)
+  register int32_t  sr = (s > 0) ?  s : 0;                                          // right shift with rounding
+  register uint64_t keep = (sl < 64 && sr < 64) ? ~uint64_t(0) : uint64_t(0);       // shifting by 64 bits and more pushes out all bits - the result is 0
+
+  sl &= 63;  sr &= 63;
+
+  register uint64_t half = (uint64_t(1) << sr) >> 1;                               // 0 if there is no right shift
+
+  a = int64_t(uint64_t(a) << sl);
+
+  // arithmetic shift plus the first shifted out bit (so there is no overflow of a + half):  ties are rounded up (toward +infinity)
+  //
+  return int64_t( uint64_t( (a >> sr) + int64_t((uint64_t(a) & half) != 0) ) & keep );
+}
+
+
+template <typename T>
+inline void fixed::quantize_span(const fixed *src, T *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point, int32_t lo, int32_t hi)
+{
+  register int64_t  m  = multiplier.ff;
+  register int32_t  s  = 48 - int32_t(shift);                                 // both the value and the multiplier are multiplied by 2^24
+  register uint64_t um = (m < 0) ? uint64_t(0) - uint64_t(m) : uint64_t(m);
+
+  // граница |x|, начиная с которой результат заведомо за пределами [lo, hi]:  bound = 2^k,  k = ceil(log2(l)) + s - floor(log2|m|)
+  //  (values beyond it are clamped to it before the multiplication, so the product can not overflow and the result still saturates)
+  //
+  register int64_t l = int64_t(hi) - zero_point;
+
+  if(int64_t(zero_point) - lo > l)  { l = int64_t(zero_point) - lo; }
+  if(l < 0)  { l = 0; }
+  l += 1;                                                                       // |result| >= l  is out of [lo, hi] for sure
+
+  register int32_t k = s;
+
+  for(int64_t  p = 1;  p < l;  p <<= 1)  { k++; }
+  for(uint64_t v = um; v > 1;  v >>= 1)  { k--; }
+
+  if(k < 0)  { k = 0; }
+
+  register int64_t bound = (um == 0 || k > 62) ? int64_t(~uint64_t(0) >> 1) : (int64_t(1) << k);
+
+  // цикл без ветвлений (точное произведение, округление сдвигом, ограничение через min/max) - компилятор векторизует его
+  //  (on x86 it needs 64-bit vector compares, i.e. -msse4.2 / -mavx2 and higher)
+  //
+  for(uint32_t i = 0; i < n; i++)
+  {
+    register int64_t x = src[i].ff;
+
+    x = (x < -bound) ? -bound : x;
+    x = (x >  bound) ?  bound : x;
+
+    // x * m = (xh * 2^24 + xl) * m = S * 2^24 + F,  0 <= F < 2^24  - the full product does not fit in 64 bits, S and F do
+    //
+    register int64_t p  = mul64(x & 0xFFFFFF, m);
+    register int64_t S  = mul64(x >> 24, m) + (p >> 24);
+    register int64_t F  = p & 0xFFFFFF;
+
+    register int64_t a = round_shift(S, s - 24) + round_shift(F, s) + zero_point;    // round(S * 2^(24-s)) + round(F * 2^-s) = round((S * 2^24 + F) * 2^-s)
+
+    a = (a < lo) ? lo : a;
+    a = (a > hi) ? hi : a;
+
+    dst[i] = T(a);
+  }
+}
+
+
+template <typename T>
+inline void fixed::dequantize_span(const T *src, fixed *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point)
+{
+  register int64_t m = multiplier.ff;
+
+  for(uint32_t i = 0; i < n; i++)
+  {
+    dst[i].ff = scale_raw(int64_t(int32_t(src[i]) - zero_point), m, shift);
+  }
+}
+
+
+inline void fixed::quantize  (const fixed   *src,  int8_t *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point)  { quantize_span(src, dst, n, multiplier, shift, zero_point,   -128,   127); }
+inline void fixed::quantize  (const fixed   *src, int16_t *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point)  { quantize_span(src, dst, n, multiplier, shift, zero_point, -32768, 32767); }
+inline void fixed::dequantize(const  int8_t *src, fixed   *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point)  { dequantize_span(src, dst, n, multiplier, shift, zero_point); }
+inline void fixed::dequantize(const int16_t *src, fixed   *dst, uint32_t n, const fixed &multiplier, int8_t shift, int32_t zero_point)  { dequantize_span(src, dst, n, multiplier, shift, zero_point); }
+
+
+inline void fixed::quantize(const fixed *src, int8_t *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point)
+{
+  for(uint32_t c = 0; c < channels; c++)  { quantize_span(src + c*inner, dst + c*inner, inner, multipliers[c], shifts[c], zero_point, -128, 127); }
+}
+
+
+inline void fixed::quantize(const fixed *src, int16_t *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point)
+{
+  for(uint32_t c = 0; c < channels; c++)  { quantize_span(src + c*inner, dst + c*inner, inner, multipliers[c], shifts[c], zero_point, -32768, 32767); }
+}
+
+
+inline void fixed::dequantize(const int8_t *src, fixed *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point)
+{
+  for(uint32_t c = 0; c < channels; c++)  { dequantize_span(src + c*inner, dst + c*inner, inner, multipliers[c], shifts[c], zero_point); }
+}
+
+
+inline void fixed::dequantize(const int16_t *src, fixed *dst, uint32_t channels, uint32_t inner, const fixed *multipliers, const int8_t *shifts, int32_t zero_point)
+{
+  for(uint32_t c = 0; c < channels; c++)  { dequantize_span(src + c*inner, dst + c*inner, inner, multipliers[c], shifts[c], zero_point); }
+}
+
+
+inline void fixed::gemv_span(const int8_t *w, const int8_t *x, fixed *y, uint32_t rows, uint32_t cols, int32_t w_zero_point, int32_t x_zero_point, const fixed *multipliers, const int8_t *shifts, uint32_t step)
+{
+  // sum (w - wz)(x - xz)  =  sum w*x  -  xz * sum w  -  wz * sum x  +  cols * wz * xz
+  //  so the inner loop is a plain int8 x int8 -> int32 dot product, which is vectorized by the compiler
+  //
+  register int32_t sum_x = 0;
+
+  for(uint32_t c = 0; c < cols; c++)  { sum_x += x[c]; }
+
+  register int32_t bias = int32_t(cols) * w_zero_point * x_zero_point - w_zero_point * sum_x;
+
+  for(uint32_t r = 0; r < rows; r++)
+  {
+    const int8_t *wr = w + r*cols;
+
+    int32_t acc = 0, sum_w = 0;
+
+    for(uint32_t c = 0; c < cols; c++)
+    {
+      acc   += int32_t(wr[c]) * int32_t(x[c]);
+      sum_w += wr[c];
+    }
+
+    acc += bias - x_zero_point * sum_w;
+
+    y[r].ff += scale_raw(int64_t(acc), multipliers[r*step].ff, shifts[r*step]);
+  }
+}
+
+
+inline void fixed::gemv(const int8_t *w, const int8_t *x, fixed *y, uint32_t rows, uint32_t cols, int32_t w_zero_point, int32_t x_zero_point, const fixed *multipliers, const int8_t *shifts)
+{
+  gemv_span(w, x, y, rows, cols, w_zero_point, x_zero_point, multipliers, shifts, 1);
+}
+
+
+inline void fixed::gemv(const int8_t *w, const int8_t *x, fixed *y, uint32_t rows, uint32_t cols, int32_t w_zero_point, int32_t x_zero_point, const fixed &multiplier, int8_t shift)
+{
+  gemv_span(w, x, y, rows, cols, w_zero_point, x_zero_point, &multiplier, &shift, 0);
+}
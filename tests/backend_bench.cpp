@@ -0,0 +1,88 @@
+//
+// замер тактов (rdtsc, x86) операций fixed для обычной 64-битной арифметики и __fixed_use_32bit_arithmetics
+//
+//   g++ -std=c++11 -O2 -Wno-register tests/backend_bench.cpp -o backend_bench && ./backend_bench
+//
+// on x86-64 the 64-bit multiply/divide are native, so the 32-bit backend is expected to be slower here;
+//  the numbers are meant for comparison between builds and for the targets without 64-bit multiply/divide (build with -m32 etc.)
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <x86intrin.h>
+
+namespace fx64
+{
+  #include "../fixed.hpp"
+}
+
+#define  __fixed_use_32bit_arithmetics
+
+namespace fx32
+{
+  #include "../fixed.hpp"
+}
+
+
+static const int N      = 4096;
+static const int ROUNDS = 200;
+
+static int64_t a[N], b[N];
+
+static volatile int64_t sink;
+
+
+template <typename F>  static F from_raw(int64_t v)  { F x;  memcpy(&x, &v, sizeof(v));  return x; }
+template <typename F>  static int64_t raw(const F &x) { int64_t v;  memcpy(&v, &x, sizeof(v));  return v; }
+
+
+// тело замера:  op(x, y) over all pairs, ROUNDS times;  cycles per operation
+//
+template <typename F, typename Op>
+static double measure(Op op)
+{
+  static F x[N], y[N];
+
+  for(int i = 0; i < N; i++)  { x[i] = from_raw<F>(a[i]);  y[i] = from_raw<F>(b[i]); }
+
+  int64_t  acc = 0;
+  uint64_t t0  = __rdtsc();
+
+  for(int r = 0; r < ROUNDS; r++)
+  {
+    for(int i = 0; i < N; i++)  { acc += raw(op(x[i], y[i])); }
+  }
+
+  uint64_t t1 = __rdtsc();
+
+  sink = acc;
+  return double(t1 - t0) / (double(N) * ROUNDS);
+}
+
+
+template <typename F>  static F op_mul(const F &x, const F &y)  { return x * y; }
+template <typename F>  static F op_div(const F &x, const F &y)  { return x / y; }
+
+template <typename F>  static F op_mul64(const F &x, const F &y)  { return from_raw<F>(F::mul64(raw(x), raw(y))); }
+template <typename F>  static F op_div64(const F &x, const F &y)  { return from_raw<F>(F::div64(raw(x), raw(y))); }
+
+
+int main()
+{
+  uint64_t s = 0x9E3779B97F4A7C15ULL;
+
+  for(int i = 0; i < N; i++)
+  {
+    s ^= s << 13;  s ^= s >> 7;  s ^= s << 17;  a[i] = int64_t(s % (uint64_t(1) << 40)) - (int64_t(1) << 39);      // typical 'fixed' values:  |x| < 2^15
+    s ^= s << 13;  s ^= s >> 7;  s ^= s << 17;  b[i] = int64_t(s % (uint64_t(1) << 36)) + (int64_t(1) << 20);      // nonzero divisors
+  }
+
+  printf("cycles per operation       64-bit    32-bit backend\n");
+  printf("  fixed * fixed          %8.2f  %8.2f\n", measure<fx64::fixed>(op_mul<fx64::fixed>),   measure<fx32::fixed>(op_mul<fx32::fixed>));
+  printf("  fixed / fixed          %8.2f  %8.2f\n", measure<fx64::fixed>(op_div<fx64::fixed>),   measure<fx32::fixed>(op_div<fx32::fixed>));
+  printf("  mul64                  %8.2f  %8.2f\n", measure<fx64::fixed>(op_mul64<fx64::fixed>), measure<fx32::fixed>(op_mul64<fx32::fixed>));
+  printf("  div64                  %8.2f  %8.2f\n", measure<fx64::fixed>(op_div64<fx64::fixed>), measure<fx32::fixed>(op_div64<fx32::fixed>));
+
+  return 0;
+}
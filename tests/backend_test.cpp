@@ -0,0 +1,170 @@
+//
+// побитовое сравнение __fixed_use_32bit_arithmetics с обычной 64-битной арифметикой
+//
+// fixed.hpp is included twice, into two namespaces, with and without __fixed_use_32bit_arithmetics
+//  (the header has no include guard and no includes of its own, so both classes live in one program)
+//
+//   g++ -std=c++11 -O2 -fwrapv -Wno-register tests/backend_test.cpp -o backend_test && ./backend_test
+//
+// (-fwrapv makes overflowing 64-bit operations of the reference path defined, so they can be compared too)
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace fx64
+{
+  #include "../fixed.hpp"
+}
+
+#define  __fixed_use_32bit_arithmetics
+
+namespace fx32
+{
+  #include "../fixed.hpp"
+}
+
+
+static long failures = 0;
+static long checks   = 0;
+
+static uint64_t seed = 0x9E3779B97F4A7C15ULL;
+static uint64_t rnd()  { seed ^= seed << 13;  seed ^= seed >> 7;  seed ^= seed << 17;  return seed; }
+
+
+template <typename F>  static int64_t raw(const F &x)     { int64_t a;  memcpy(&a, &x, sizeof(a));  return a; }
+template <typename F>  static F       from_raw(int64_t a) { F x;  memcpy(&x, &a, sizeof(a));  return x; }
+
+
+static void expect(const char *what, int64_t a, int64_t b, uint64_t got, uint64_t ref)
+{
+  checks++;
+
+  if(got != ref)
+  {
+    if(failures++ < 20)  { printf("FAILED: %s  a=%lld b=%lld:  got %llx, expected %llx\n", what, (long long)a, (long long)b, (unsigned long long)got, (unsigned long long)ref); }
+  }
+}
+
+
+// operand patterns: small values, values around word boundaries, full-range and shifted random values
+//
+static int64_t pick()
+{
+  static const int64_t edges[] =
+  {
+    0, 1, -1, 2, -2, 255, 256, -256, 65535, 65536, -65536,
+    0x7FFFFFFFLL, 0x80000000LL, 0xFFFFFFFFLL, 0x100000000LL, -0x100000000LL, 0x100000001LL,
+    0x7FFFFFFFFFFFFFFFLL, -0x7FFFFFFFFFFFFFFFLL, 0x7FFFFFFF00000000LL, 0x0000FFFF0000FFFFLL, 0x00FF00FF00FF00FFLL
+  };
+
+  uint64_t r = rnd();
+
+  switch(r % 8)
+  {
+    case 0:   return edges[rnd() % (sizeof(edges)/sizeof(edges[0]))];
+    case 1:   return int64_t(rnd());
+    case 2:   return int64_t(rnd() >> (rnd() % 64));
+    case 3:   return -int64_t(rnd() >> (rnd() % 64 + 1));
+    case 4:   return int64_t(rnd() & 0xFFFFFFFF);
+    case 5:   return int64_t(rnd() % (uint64_t(1) << 40)) - (int64_t(1) << 39);        // typical 'fixed' values (|x| < 2^15)
+    case 6:   return (int64_t(1) << (rnd() % 63)) + int64_t(rnd() % 3) - 1;
+    default:  return int64_t(rnd() % 2001) - 1000;
+  }
+}
+
+
+static void compare(int64_t a, int64_t b)
+{
+  // 64-битные примитивы против встроенных операций
+  //
+  expect("mul64",  a, b, uint64_t(fx32::fixed::mul64(a, b)), uint64_t(a) * uint64_t(b));
+  expect("mul64 (64-bit backend)", a, b, uint64_t(fx64::fixed::mul64(a, b)), uint64_t(a) * uint64_t(b));
+
+  if(b != 0)
+  {
+    expect("udiv64", a, b, fx32::fixed::udiv64(uint64_t(a), uint64_t(b)), uint64_t(a) / uint64_t(b));
+
+    if(!(a == (-0x7FFFFFFFFFFFFFFFLL - 1) && b == -1))         // the only overflowing signed division
+    {
+      expect("div64", a, b, uint64_t(fx32::fixed::div64(a, b)), uint64_t(a / b));
+    }
+  }
+
+  // операции класса fixed
+  //
+  fx64::fixed x64 = from_raw<fx64::fixed>(a),  y64 = from_raw<fx64::fixed>(b);
+  fx32::fixed x32 = from_raw<fx32::fixed>(a),  y32 = from_raw<fx32::fixed>(b);
+
+  expect("fixed * fixed", a, b, raw(x32 * y32), raw(x64 * y64));
+  expect("fixed / fixed", a, b, raw(x32 / y32), raw(x64 / y64));
+
+  { fx64::fixed z64 = x64;  z64 *= y64;  fx32::fixed z32 = x32;  z32 *= y32;  expect("fixed *= fixed", a, b, raw(z32), raw(z64)); }
+  { fx64::fixed z64 = x64;  z64 /= y64;  fx32::fixed z32 = x32;  z32 /= y32;  expect("fixed /= fixed", a, b, raw(z32), raw(z64)); }
+
+  int32_t  i = int32_t(b);
+  uint64_t u = uint64_t(b);
+
+  expect("fixed * int32",  a, b, raw(x32 * i), raw(x64 * i));
+  expect("fixed * uint64", a, b, raw(x32 * u), raw(x64 * u));
+
+  // fixed / integer against fixed /= integer (both backends), then the 32-bit backend against the 64-bit one
+  //
+  if(i != 0 && !(a == (-0x7FFFFFFFFFFFFFFFLL - 1) && i == -1))
+  {
+    fx64::fixed z64 = x64;  z64 /= i;  fx32::fixed z32 = x32;  z32 /= i;
+
+    expect("fixed / int32 (64-bit backend)", a, b, raw(x64 / i), raw(z64));
+    expect("fixed / int32",  a, b, raw(x32 / i), raw(z32));
+    expect("fixed /= int32", a, b, raw(z32), raw(z64));
+  }
+
+  if(u != 0)
+  {
+    fx64::fixed z64 = x64;  z64 /= u;  fx32::fixed z32 = x32;  z32 /= u;
+
+    expect("fixed / uint64 (64-bit backend)", a, b, raw(x64 / u), raw(z64));
+    expect("fixed / uint64",  a, b, raw(x32 / u), raw(z32));
+    expect("fixed /= uint64", a, b, raw(z32), raw(z64));
+  }
+}
+
+
+int main()
+{
+  const long N = 5000000;
+
+  for(long n = 0; n < N; n++)  { compare(pick(), pick()); }
+
+  // quantize/dequantize/gemv go through mul64 as well
+  //
+  {
+    const int M = 4096;
+    static fx64::fixed s64[M], d64[M];
+    static fx32::fixed s32[M], d32[M];
+    static int16_t q64[M], q32[M];
+
+    for(int k = 0; k < M; k++)  { int64_t v = int64_t(rnd() % (uint64_t(1) << 38)) - (int64_t(1) << 37);  s64[k] = from_raw<fx64::fixed>(v);  s32[k] = from_raw<fx32::fixed>(v); }
+
+    fx64::fixed m64 = from_raw<fx64::fixed>(0xC0FFEE);
+    fx32::fixed m32 = from_raw<fx32::fixed>(0xC0FFEE);
+
+    fx64::fixed::quantize(s64, q64, M, m64, 3, -11);
+    fx32::fixed::quantize(s32, q32, M, m32, 3, -11);
+
+    fx64::fixed::dequantize(q64, d64, M, m64, -7, 5);
+    fx32::fixed::dequantize(q32, d32, M, m32, -7, 5);
+
+    for(int k = 0; k < M; k++)
+    {
+      expect("quantize",   k, 0, uint64_t(q32[k]), uint64_t(q64[k]));
+      expect("dequantize", k, 0, raw(d32[k]), raw(d64[k]));
+    }
+  }
+
+  if(failures != 0)  { printf("backend_test: %ld of %ld checks failed\n", failures, checks);  return 1; }
+
+  printf("backend_test: ok (%ld checks)\n", checks);
+  return 0;
+}
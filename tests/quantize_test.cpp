@@ -0,0 +1,296 @@
+//
+// проверка fixed::quantize / dequantize / gemv по эталону
+//  (quantize - exact 128-bit product (__int128, GCC/Clang);  dequantize/gemv - long double, its 64-bit mantissa holds their products exactly)
+//
+//   g++ -std=c++11 -O2 -msse4.2 -Wno-register tests/quantize_test.cpp -o quantize_test && ./quantize_test
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "../fixed.hpp"
+
+
+static int failures = 0;
+
+#define CHECK(cond)  do { if(!(cond)) { failures++;  printf("FAILED: %s  (line %d)\n", #cond, __LINE__); } } while(0)
+
+
+static int64_t raw(const fixed &x)     { int64_t a;  memcpy(&a, &x, sizeof(a));  return a; }
+static fixed   from_raw(int64_t a)     { fixed x;  memcpy(&x, &a, sizeof(a));  return x; }
+
+static uint64_t seed = 0x2545F4914F6CDD1DULL;
+static uint64_t rnd()  { seed ^= seed << 13;  seed ^= seed >> 7;  seed ^= seed << 17;  return seed; }
+
+
+// round(a * 2^e), ties up
+static int64_t ref_round(long double a, int e)  { return (int64_t)floorl(ldexpl(a, e) + 0.5L); }
+
+static int64_t ref_clamp(int64_t a, int64_t lo, int64_t hi)  { return (a < lo) ? lo : ((a > hi) ? hi : a); }
+
+static int64_t ref_quantize(const fixed &x, const fixed &m, int shift, int32_t zp, int64_t lo, int64_t hi)
+{
+  __int128 p = (__int128)raw(x) * raw(m);
+  int      s = 48 - shift;
+
+  p = (s > 0) ? ((p + ((__int128)1 << (s-1))) >> s) : (p << -s);      // round(x * m * 2^shift), ties up
+  p += zp;
+
+  return (p < lo) ? lo : ((p > hi) ? hi : (int64_t)p);
+}
+
+static int64_t ref_dequantize(int32_t q, const fixed &m, int shift, int32_t zp)
+{
+  return ref_round((long double)(q - zp) * raw(m), shift);
+}
+
+
+static void test_ties_and_clamp()
+{
+  const fixed one(int32_t(1));
+  int8_t  q8[8];
+  int16_t q16[4];
+
+  // ties are rounded up (toward +infinity)
+  fixed t[8] = { fixed(0.5), fixed(-0.5), fixed(1.5), fixed(-1.5), fixed(2.5), fixed(-2.5), from_raw(1), from_raw(-1) };
+
+  fixed::quantize(t, q8, 8, one, 0, 0);
+
+  CHECK(q8[0] ==  1);  CHECK(q8[1] ==  0);  CHECK(q8[2] == 2);  CHECK(q8[3] == -1);
+  CHECK(q8[4] ==  3);  CHECK(q8[5] == -2);  CHECK(q8[6] == 0);  CHECK(q8[7] ==  0);
+
+  // clamping together with a nonzero zero point
+  fixed c[4] = { fixed(int32_t(116)), fixed(int32_t(118)), fixed(int32_t(-137)), fixed(int32_t(-139)) };
+
+  fixed::quantize(c, q8, 4, one, 0, 10);
+
+  CHECK(q8[0] == 126);  CHECK(q8[1] == 127);  CHECK(q8[2] == -127);  CHECK(q8[3] == -128);
+
+  fixed d[4] = { fixed(int32_t(32767)), fixed(int32_t(40000)), fixed(int32_t(-32768)), fixed(int32_t(-40000)) };
+
+  fixed::quantize(d, q16, 4, fixed(0.5), 0, 0);
+
+  CHECK(q16[0] == 16384);  CHECK(q16[1] == 20000);  CHECK(q16[2] == -16384);  CHECK(q16[3] == -20000);
+
+  fixed::quantize(d, q16, 4, one, 0, -5);
+
+  CHECK(q16[0] == 32762);  CHECK(q16[1] == 32767);  CHECK(q16[2] == -32768);  CHECK(q16[3] == -32768);
+}
+
+
+static void test_saturation()
+{
+  // |x| >= 2^15:  x * multiplier does not fit in 64 bits (as a product of two values multiplied by 2^24), the result must still saturate
+  //
+  const int K = 8;
+
+  fixed s[K] = { fixed(int32_t(40000)), fixed(int32_t(-40000)), fixed(int32_t(100000)), fixed(int32_t(1000000)), fixed(int32_t(-1000000)),
+                 from_raw(0x7FFFFFFFFFFFFFFFLL), from_raw(-0x7FFFFFFFFFFFFFFFLL - 1), fixed(int64_t(1) << 38) };
+
+  int16_t q16[K];
+  int8_t  q8[K];
+
+  const int32_t exp16[K] = { 32767, -32768, 32767, 32767, -32768, 32767, -32768, 32767 };
+  const int32_t exp8[K]  = {   127,   -128,   127,   127,   -128,   127,   -128,   127 };
+
+  fixed::quantize(s, q16, K, fixed(int32_t(1)), 0, 0);
+  fixed::quantize(s, q8,  K, fixed(int32_t(1)), 0, 0);
+
+  for(int i = 0; i < K; i++)  { CHECK(q16[i] == exp16[i]);  CHECK(q8[i] == exp8[i]); }
+
+  fixed::quantize(s, q16, K, fixed(int32_t(-3)), 2, 100);         // negative multiplier:  the sign of the saturation is flipped
+  fixed::quantize(s, q8,  K, fixed(int32_t(-3)), 2, -100);
+
+  for(int i = 0; i < K; i++)  { CHECK(q16[i] == -1 - exp16[i]);  CHECK(q8[i] == -1 - exp8[i]); }
+
+  // values just below and above the saturation point, and the whole range of 'fixed' with various factors
+  //
+  const int N = 100000;
+  static fixed   x[N];
+  static int16_t r16[N];
+  static int8_t  r8[N];
+
+  const fixed  m[5]  = { fixed(int32_t(1)), fixed(0.0371), from_raw(1), fixed(int32_t(32767)), fixed(-0.75) };
+  const int8_t sh[5] = { 0, -20, 40, -5, 10 };
+
+  int bad = 0;
+
+  for(int t = 0; t < 5; t++)
+  {
+    for(int i = 0; i < N; i++)
+    {
+      uint64_t r = rnd();
+      x[i] = from_raw( (r & 1) ? int64_t(rnd()) : (int64_t(rnd() >> (rnd() % 64)) * ((r & 2) ? 1 : -1)) );
+    }
+
+    fixed::quantize(x, r16, N, m[t], sh[t], 7);
+    fixed::quantize(x, r8,  N, m[t], sh[t], -7);
+
+    for(int i = 0; i < N; i++)
+    {
+      if(r16[i] != ref_quantize(x[i], m[t], sh[t],  7, -32768, 32767))  { bad++; }
+      if(r8[i]  != ref_quantize(x[i], m[t], sh[t], -7,   -128,   127))  { bad++; }
+    }
+  }
+
+  CHECK(bad == 0);
+}
+
+
+static void test_quantize_random()
+{
+  const int N = 200000;
+  static fixed   x[N];
+  static int8_t  q8[N];
+  static int16_t q16[N];
+
+  const fixed m(1.0/0.0371);          // scale 0.0371:  q = x / 0.0371
+
+  for(int i = 0; i < N; i++)  { x[i] = from_raw(int64_t(rnd() % (uint64_t(2400) << 24)) - (int64_t(1200) << 24)); }
+
+  fixed::quantize(x, q16, N, m, 0, 7);
+  fixed::quantize(x, q8,  N, m, -4, -3);
+
+  int bad16 = 0, bad8 = 0;
+
+  for(int i = 0; i < N; i++)
+  {
+    if(q16[i] != ref_quantize(x[i], m,  0,  7, -32768, 32767))  { bad16++; }
+    if(q8[i]  != ref_quantize(x[i], m, -4, -3,   -128,   127))  { bad8++;  }
+  }
+
+  CHECK(bad16 == 0);
+  CHECK(bad8  == 0);
+}
+
+
+static void test_dequantize()
+{
+  int8_t  q8[256];
+  int16_t q16[256];
+  fixed   y[256];
+
+  const fixed m(0.0371);
+
+  for(int i = 0; i < 256; i++)  { q8[i] = int8_t(i - 128);  q16[i] = int16_t(int32_t(rnd() & 0xFFFF) - 32768); }
+
+  fixed::dequantize(q8, y, 256, m, -3, 5);
+
+  int bad = 0;
+  for(int i = 0; i < 256; i++)  { if(raw(y[i]) != ref_dequantize(q8[i], m, -3, 5))  { bad++; } }
+  CHECK(bad == 0);
+
+  fixed::dequantize(q16, y, 256, m, 2, -100);
+
+  bad = 0;
+  for(int i = 0; i < 256; i++)  { if(raw(y[i]) != ref_dequantize(q16[i], m, 2, -100))  { bad++; } }
+  CHECK(bad == 0);
+
+  // round trip through the inverse factor
+  fixed x[4] = { fixed(int32_t(1)), fixed(-0.25), fixed(int32_t(3)), fixed(0.125) };
+
+  fixed::quantize(x, q8, 4, fixed(int32_t(1)), 5, 0);        // * 32
+  fixed::dequantize(q8, y, 4, fixed(int32_t(1)), -5, 0);     // / 32
+
+  for(int i = 0; i < 4; i++)  { CHECK(raw(y[i]) == raw(x[i])); }
+}
+
+
+static void test_per_channel()
+{
+  const uint32_t channels = 3, inner = 50;
+
+  fixed   x[channels*inner], y[channels*inner];
+  int8_t  q8[channels*inner];
+  int16_t q16[channels*inner];
+
+  fixed  m[channels]  = { fixed(0.75), fixed(int32_t(1)), fixed(0.5625) };
+  int8_t sh[channels] = { 3, -1, 6 };
+
+  for(uint32_t i = 0; i < channels*inner; i++)  { x[i] = from_raw(int64_t(rnd() % (uint64_t(64) << 24)) - (int64_t(32) << 24)); }
+
+  fixed::quantize(x, q8,  channels, inner, m, sh, 4);
+  fixed::quantize(x, q16, channels, inner, m, sh, -4);
+
+  int bad = 0;
+
+  for(uint32_t c = 0; c < channels; c++)
+  {
+    for(uint32_t i = c*inner; i < (c+1)*inner; i++)
+    {
+      if(q8[i]  != ref_quantize(x[i], m[c], sh[c],  4,   -128,   127))  { bad++; }
+      if(q16[i] != ref_quantize(x[i], m[c], sh[c], -4, -32768, 32767))  { bad++; }
+    }
+  }
+  CHECK(bad == 0);
+
+  fixed::dequantize(q16, y, channels, inner, m, sh, -4);
+
+  bad = 0;
+  for(uint32_t c = 0; c < channels; c++)
+  {
+    for(uint32_t i = c*inner; i < (c+1)*inner; i++)  { if(raw(y[i]) != ref_dequantize(q16[i], m[c], sh[c], -4))  { bad++; } }
+  }
+  CHECK(bad == 0);
+
+  fixed::dequantize(q8, y, channels, inner, m, sh, 4);
+
+  bad = 0;
+  for(uint32_t c = 0; c < channels; c++)
+  {
+    for(uint32_t i = c*inner; i < (c+1)*inner; i++)  { if(raw(y[i]) != ref_dequantize(q8[i], m[c], sh[c], 4))  { bad++; } }
+  }
+  CHECK(bad == 0);
+}
+
+
+static void test_gemv()
+{
+  const uint32_t rows = 7, cols = 37;
+  const int32_t  wz = 3, xz = -9;
+
+  int8_t w[rows*cols], x[cols];
+  fixed  m[rows], y[rows], yt[rows];
+  int8_t sh[rows];
+
+  for(uint32_t i = 0; i < rows*cols; i++)  { w[i] = int8_t(rnd()); }
+  for(uint32_t i = 0; i < cols;      i++)  { x[i] = int8_t(rnd()); }
+
+  for(uint32_t r = 0; r < rows; r++)
+  {
+    m[r]  = from_raw(int64_t(rnd() % (uint64_t(1) << 24)) + 1);
+    sh[r] = int8_t(int32_t(r) - 4);
+    y[r]  = fixed(int32_t(r));          // gemv accumulates into y
+    yt[r] = fixed(int32_t(r));
+  }
+
+  fixed::gemv(w, x, y,  rows, cols, wz, xz, m, sh);
+  fixed::gemv(w, x, yt, rows, cols, wz, xz, m[2], sh[2]);
+
+  for(uint32_t r = 0; r < rows; r++)
+  {
+    int64_t acc = 0;
+    for(uint32_t c = 0; c < cols; c++)  { acc += int64_t(w[r*cols + c] - wz) * (x[c] - xz); }
+
+    CHECK(raw(y[r])  == (int64_t(r) << 24) + ref_round((long double)acc * raw(m[r]), sh[r]));
+    CHECK(raw(yt[r]) == (int64_t(r) << 24) + ref_round((long double)acc * raw(m[2]), sh[2]));
+  }
+}
+
+
+int main()
+{
+  test_ties_and_clamp();
+  test_saturation();
+  test_quantize_random();
+  test_dequantize();
+  test_per_channel();
+  test_gemv();
+
+  if(failures != 0)  { printf("quantize_test: %d check(s) failed\n", failures);  return 1; }
+
+  printf("quantize_test: ok\n");
+  return 0;
+}
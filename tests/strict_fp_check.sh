@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# проверка строго целочисленного режима (__fixed_strict_integer):
+#
+#  - tests/strict_hot_paths.cpp is built with and without __fixed_use_32bit_arithmetics, disassembled by objdump,
+#    and any x87 / SSE / AVX floating-point instruction fails the check:  x87 (f*), conversions (cvt*), scalar (*ss, *sd, comis*, ucomis*),
+#    packed arithmetic (add/sub/mul/div/sqrt/min/max/cmp/round/rcp/rsqrt/hadd/hsub/addsub/dp + ps/pd) and FMA (vfmadd... etc.)
+#  - mixed float/double expressions (STRICT_REJECT_n in the same source) must not compile
+#
+#   sh tests/strict_fp_check.sh          (x86 / x86-64;  CXX and OBJDUMP may be overridden)
+#
+
+CXX=${CXX:-g++}
+OBJDUMP=${OBJDUMP:-objdump}
+
+cd "$(dirname "$0")/.." || exit 1
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+status=0
+
+# integer SIMD mnemonics start with 'p' / 'vp' (pminsd, vpmuludq ...), they are allowed, as well as the packed data movement
+#  and bitwise forms which GCC uses on integer data too (mov*ps/pd, shufps, unpck*, and*/or*/xor*, blend*)
+#
+fp_filter='
+  /^[0-9a-f]+ <.*>:$/  { fn = $0;  next }
+  NF >= 2 {
+    split($2, w, " ");  m = w[1];
+    if( m !~ /^v?p/ && (m ~ /^f/ || m ~ /^v?cvt/ || m ~ /^v?u?comis/ || m ~ /(ss|sd)$/ ||
+                        m ~ /^v?(add|sub|mul|div|sqrt|min|max|cmp[a-z]*|round|rcp|rsqrt|hadd|hsub|addsub|dp)(ps|pd)$/ ||
+                        m ~ /^vf(n?m(add|sub)|maddsub|msubadd)[0-9]*(ps|pd|ss|sd)$/) )  { print fn "  " $2 }
+  }'
+
+for backend in "" "-D__fixed_use_32bit_arithmetics"
+do
+  for opt in "-O0" "-O2" "-O3 -mavx2"
+  do
+    what="strict ${backend:-(64-bit)} $opt"
+
+    if ! $CXX -std=c++11 $opt -Wno-register -D__fixed_strict_integer $backend -c tests/strict_hot_paths.cpp -o "$tmp/hot.o"
+    then
+      echo "FAILED: $what: does not compile";  status=1;  continue
+    fi
+
+    $OBJDUMP -d --no-show-raw-insn "$tmp/hot.o" | awk -F'\t' "$fp_filter" > "$tmp/fp.txt"
+
+    if [ -s "$tmp/fp.txt" ]
+    then
+      echo "FAILED: $what: floating-point instructions in fixed operations:";  cat "$tmp/fp.txt";  status=1
+    else
+      echo "ok: $what: no floating-point instructions"
+    fi
+  done
+done
+
+for n in 1 2 3 4 5 6 7
+do
+  if $CXX -std=c++11 -Wno-register -D__fixed_strict_integer -DSTRICT_REJECT_$n -fsyntax-only tests/strict_hot_paths.cpp 2>/dev/null
+  then
+    echo "FAILED: STRICT_REJECT_$n: mixed float expression is accepted";  status=1
+  else
+    echo "ok: STRICT_REJECT_$n is rejected"
+  fi
+done
+
+exit $status
@@ -0,0 +1,74 @@
+//
+// горячие пути класса fixed для проверки строго целочисленного режима (tests/strict_fp_check.sh)
+//
+// the object file built from this source must not contain any floating-point instruction;
+//  only operations of class 'fixed' are here (no explicit float/double boundary conversions)
+//
+// STRICT_REJECT_n:  mixed float/double expressions which must be rejected at compile time
+//
+
+#include <stdint.h>
+
+#ifndef __fixed_strict_integer
+  #error "build with -D__fixed_strict_integer"
+#endif
+
+#include "../fixed.hpp"
+
+
+#define HOT  __attribute__((noinline))
+
+HOT fixed hot_add   (fixed a, fixed b)    { return a + b; }
+HOT fixed hot_sub   (fixed a, fixed b)    { return a - b; }
+HOT fixed hot_mul   (fixed a, fixed b)    { return a * b; }
+HOT fixed hot_div   (fixed a, fixed b)    { return a / b; }
+HOT fixed hot_neg   (fixed a)             { return -a; }
+
+HOT fixed hot_cmul  (fixed a, fixed b)    { a *= b;  return a; }
+HOT fixed hot_cdiv  (fixed a, fixed b)    { a /= b;  return a; }
+HOT fixed hot_cadd  (fixed a, fixed b)    { a += b;  a -= b;  a += b;  return a; }
+
+HOT fixed hot_addi  (fixed a, int32_t b)  { return a + b; }
+HOT fixed hot_subi  (fixed a, int32_t b)  { return a - b; }
+HOT fixed hot_muli  (fixed a, int32_t b)  { return a * b; }
+HOT fixed hot_divi  (fixed a, int32_t b)  { return a / b; }
+HOT fixed hot_mulu  (fixed a, uint64_t b) { return a * b; }
+HOT fixed hot_divu  (fixed a, uint64_t b) { return a / b; }
+HOT fixed hot_cmuli (fixed a, int16_t b)  { a *= b;  return a; }
+HOT fixed hot_cdivi (fixed a, int64_t b)  { a /= b;  return a; }
+
+HOT bool  hot_lt    (fixed a, fixed b)    { return a < b; }
+HOT bool  hot_eq    (fixed a, fixed b)    { return a == b; }
+HOT bool  hot_lti   (fixed a, int32_t b)  { return a < b; }
+HOT bool  hot_gei   (fixed a, int64_t b)  { return a >= b; }
+
+HOT int   hot_toint (fixed a)             { return int(a); }
+HOT fixed hot_fromi (int32_t a)           { return fixed(a); }
+
+HOT void  hot_quantize8  (const fixed *s, int8_t  *d, uint32_t n, const fixed &m, int8_t sh)  { fixed::quantize(s, d, n, m, sh, 3); }
+HOT void  hot_quantize16 (const fixed *s, int16_t *d, uint32_t n, const fixed *m, const int8_t *sh)  { fixed::quantize(s, d, 4, n, m, sh, -3); }
+HOT void  hot_dequantize (const int8_t *s, fixed *d, uint32_t n, const fixed &m, int8_t sh)  { fixed::dequantize(s, d, n, m, sh, 3); }
+HOT void  hot_gemv       (const int8_t *w, const int8_t *x, fixed *y, uint32_t r, uint32_t c, const fixed *m, const int8_t *sh)  { fixed::gemv(w, x, y, r, c, 1, -2, m, sh); }
+
+
+#ifdef STRICT_REJECT_1
+fixed reject(fixed a)  { return a * 0.5; }
+#endif
+#ifdef STRICT_REJECT_2
+fixed reject(fixed a)  { return 0.5 * a; }
+#endif
+#ifdef STRICT_REJECT_3
+bool  reject(fixed a)  { return a < 0.5; }
+#endif
+#ifdef STRICT_REJECT_4
+fixed reject(fixed a)  { a += 0.5f;  return a; }
+#endif
+#ifdef STRICT_REJECT_5
+fixed reject()         { fixed r = 0.5;  return r; }
+#endif
+#ifdef STRICT_REJECT_6
+double reject(fixed a) { double r = a;  return r; }
+#endif
+#ifdef STRICT_REJECT_7
+fixed reject(fixed a)  { return a / 3.0f; }
+#endif